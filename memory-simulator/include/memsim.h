@@ -46,6 +46,7 @@ struct Cache{
 
 void init_cache(Cache &c,string name,size_t cache_size,size_t block_size,size_t associativity,ReplacementPolicy policy);
 bool access_cache(Cache &c, size_t address);
+bool warm_cache(Cache &c, size_t address);
 void print_cache_stats(const Cache &c);
 
 // VIRTUAL MEMORY
@@ -57,6 +58,9 @@ enum VMReplacement
 
 void init_vm(size_t physical_memory_size, size_t page_size);
 size_t translate_address(size_t virtual_addr);
+size_t warm_translate(size_t virtual_addr);
+size_t get_page_faults();
+int vm_node_of(size_t physical_addr);
 void set_vm_policy(VMReplacement p);
 void print_vm_stats();
 void dump_page_table();
@@ -83,6 +87,21 @@ int allocate_block(size_t size);
 bool free_block(int id);
 void dump_memory();
 void print_stats();
+int memory_node_of(size_t addr);
+void split_free_at_arenas();
+
+// Compaction (moving allocator)
+enum CompactionMode
+{
+    COMPACT_OFF,
+    COMPACT_ON_FAILURE,
+    COMPACT_INCREMENTAL
+};
+
+void set_compaction(CompactionMode mode);
+void set_compaction_budget(size_t bytes);
+size_t compact_memory(bool verbose);
+void print_compaction_stats();
 
 // BUDDY 
 void init_buddy(size_t size);
@@ -90,3 +109,125 @@ int buddy_malloc(size_t req_size);
 bool buddy_free(int id);
 void dump_buddy();
 void print_buddy_stats();
+
+// NUMA
+enum NumaPolicy
+{
+    FIRST_TOUCH,
+    INTERLEAVE,
+    BIND,
+    MIGRATE_ON_HOT
+};
+
+void init_numa(size_t nodes, size_t local_latency, size_t remote_latency);
+bool numa_enabled();
+size_t numa_node_count();
+void set_numa_latency(int node, size_t local_latency, size_t remote_latency);
+void set_numa_policy(NumaPolicy p);
+NumaPolicy get_numa_policy();
+void set_cpu_node(int node);
+int get_cpu_node();
+void set_numa_bind(int node);
+void set_numa_hot_threshold(size_t accesses);
+size_t numa_hot_threshold();
+int numa_node_of(size_t index, size_t count);
+size_t numa_range_start(int node, size_t count);
+int numa_pick_node();
+size_t numa_memory_latency(int node, size_t default_latency);
+void numa_record_placement(int node);
+void numa_record_migration(int node);
+void numa_record_alloc(int node, bool local);
+void print_numa_stats();
+
+// ACCESS TIME STATS (owned by main)
+extern size_t total_memory_accesses;
+extern size_t total_access_time;
+extern size_t l1_miss_to_l2;
+extern size_t l2_miss_to_l3;
+extern size_t l3_miss_to_memory;
+extern Cache L1, L2, L3;
+
+// strict CLI number parsing: digits only, so typos and negative values are rejected
+inline bool parse_size(const string &s, size_t &out){
+    if (s.empty()) return false;
+    for (char ch : s)
+        if (!isdigit((unsigned char)ch)) return false;
+    errno = 0;
+    unsigned long long v = strtoull(s.c_str(), nullptr, 10);
+    if (errno == ERANGE || v > SIZE_MAX) return false;
+    out = (size_t)v;
+    return true;
+}
+
+// SNAPSHOT
+// raw binary helpers shared by every module that checkpoints its state
+template <typename T>
+inline void snap_write(ostream &out, const T &v){
+    out.write(reinterpret_cast<const char *>(&v), sizeof(T));
+}
+template <typename T>
+inline bool snap_read(istream &in, T &v){
+    return (bool)in.read(reinterpret_cast<char *>(&v), sizeof(T));
+}
+template <typename T>
+inline void snap_write_vec(ostream &out, const vector<T> &v){
+    snap_write(out, (uint64_t)v.size());
+    out.write(reinterpret_cast<const char *>(v.data()), v.size() * sizeof(T));
+}
+// true if at least `bytes` are left to read, guards sizes taken from the file
+inline bool snap_fits(istream &in, uint64_t bytes){
+    return (uint64_t)max(in.rdbuf()->in_avail(), (streamsize)0) >= bytes;
+}
+template <typename T>
+inline bool snap_read_vec(istream &in, vector<T> &v){
+    uint64_t n;
+    if (!snap_read(in, n) || n > UINT64_MAX / sizeof(T) || !snap_fits(in, n * sizeof(T))) return false;
+    v.resize(n);
+    return (bool)in.read(reinterpret_cast<char *>(v.data()), n * sizeof(T));
+}
+
+void save_allocator_state(ostream &out);
+bool load_allocator_state(istream &in);
+void save_buddy_state(ostream &out);
+bool load_buddy_state(istream &in);
+void save_vm_state(ostream &out);
+bool load_vm_state(istream &in);
+void save_numa_state(ostream &out);
+bool load_numa_state(istream &in);
+
+bool save_snapshot(const string &path);
+bool load_snapshot(const string &path);
+
+// SAMPLING (systematic sampling with bounded warm-up)
+enum SampleAction
+{
+    SAMPLE_SKIP,      // no state update at all
+    SAMPLE_WARM,      // update cache / page state, no stats
+    SAMPLE_DETAIL     // full simulation, measured
+};
+
+void set_sampling(size_t period, size_t window, size_t warmup);   // period 0 disables
+bool sampling_enabled();
+SampleAction sample_next(bool is_virtual);
+void sample_record(size_t latency, int level, bool is_virtual, bool fault);
+void print_sample_stats();
+void save_sampling_state(ostream &out);
+bool load_sampling_state(istream &in);
+
+// WORKLOAD GENERATOR
+enum WorkOpKind
+{
+    OP_ACCESS,
+    OP_VM_ACCESS,
+    OP_MALLOC,
+    OP_FREE       // value is the generator handle (index of the malloc), not the allocator id
+};
+struct WorkOp
+{
+    WorkOpKind kind;
+    size_t value;
+};
+
+bool set_workload_param(const string &key, const string &value);
+bool generate_workload(const string &pattern, size_t count, uint64_t seed, const function<void(const vector<WorkOp> &)> &sink);
+bool write_workload_trace(const string &path, const string &pattern, size_t count, uint64_t seed);
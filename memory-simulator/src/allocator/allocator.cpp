@@ -20,13 +20,58 @@ size_t total_requested_memory = 0;
 size_t total_allocated_memory = 0;
 size_t total_internal_fragmentation = 0;
 
+// Compaction
+struct CompactionStats
+{
+    size_t runs = 0;            // full compactions + incremental steps that moved something
+    size_t blocks_moved = 0;
+    size_t bytes_moved = 0;
+    size_t rescued_allocs = 0;  // succeeded here but failed in the non-moving shadow layout
+    size_t lost_allocs = 0;     // failed here but succeeded in the shadow layout
+    double pause_us = 0;        // total time spent relocating
+    double max_pause_us = 0;
+};
+
+static CompactionMode compaction_mode = COMPACT_OFF;
+static size_t compaction_budget = 64;   // bytes per op in incremental mode
+static size_t compaction_credit = 0;    // unspent budget carried over so large blocks still move
+static CompactionStats cstats;
+
+// the same requests replayed without ever moving a block, to measure what compaction buys
+static vector<Block> shadow_blocks;
+
 //   Helper: Coalescing
 
-static void coalesce(){
-    for (size_t i = 0; i + 1 < memory_blocks.size();){
-        if (memory_blocks[i].free && memory_blocks[i + 1].free){
-            memory_blocks[i].size += memory_blocks[i + 1].size;
-            memory_blocks.erase(memory_blocks.begin() + i + 1);
+// NUMA arena of an address, arenas are carved in ALIGNMENT units so block starts stay aligned
+int memory_node_of(size_t addr){
+    return numa_node_of(addr / ALIGNMENT, TOTAL_MEMORY / ALIGNMENT);
+}
+
+static size_t arena_start(int node){
+    return numa_range_start(node, TOTAL_MEMORY / ALIGNMENT) * ALIGNMENT;
+}
+
+// cuts free blocks at arena boundaries, a block freed after init_numa may still span several nodes
+static void split_at_arenas(vector<Block> &blocks){
+    for (size_t i = 0; i < blocks.size(); i++){
+        if (!blocks[i].free) continue;
+        int node = memory_node_of(blocks[i].start);
+        size_t end = node + 1 < (int)numa_node_count() ? arena_start(node + 1) : TOTAL_MEMORY;
+        if (end < blocks[i].start + blocks[i].size){
+            Block tail = {end, blocks[i].start + blocks[i].size - end, 0, true, -1};
+            blocks[i].size = end - blocks[i].start;
+            blocks.insert(blocks.begin() + i + 1, tail);
+        }
+    }
+}
+
+static void coalesce(vector<Block> &blocks){
+    split_at_arenas(blocks);
+    for (size_t i = 0; i + 1 < blocks.size();){
+        if (blocks[i].free && blocks[i + 1].free &&
+            memory_node_of(blocks[i].start) == memory_node_of(blocks[i + 1].start)){
+            blocks[i].size += blocks[i + 1].size;
+            blocks.erase(blocks.begin() + i + 1);
         }
         else{
             i++;
@@ -47,19 +92,29 @@ void init_memory(size_t size){
     total_requested_memory = 0;
     total_allocated_memory = 0;
     total_internal_fragmentation = 0;
+    cstats = CompactionStats();
+    compaction_credit = 0;
+    split_free_at_arenas();
+}
+
+// re-cut free memory at the current NUMA arena boundaries so every free block belongs to one node
+void split_free_at_arenas(){
+    coalesce(memory_blocks);
+    shadow_blocks = memory_blocks;
 }
 
 // Allocation
 
-int allocate_block(size_t req)
-{
-    total_alloc_requests++;
-    total_requested_memory += req;
-    size_t aligned_req = ((req + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT;
+static bool usable(const Block &b, size_t aligned_req, int node){
+    return b.free && b.size >= aligned_req && (node < 0 || memory_node_of(b.start) == node);
+}
+
+// index of the free block chosen by the current fit strategy, restricted to `node` unless it is -1
+static int find_fit(const vector<Block> &blocks, size_t aligned_req, int node){
     int idx = -1;
     if (alloc_type == FIRST_FIT){
-        for (size_t i = 0; i < memory_blocks.size(); i++){
-            if (memory_blocks[i].free && memory_blocks[i].size >= aligned_req){
+        for (size_t i = 0; i < blocks.size(); i++){
+            if (usable(blocks[i], aligned_req, node)){
                 idx = i;
                 break;
             }
@@ -67,45 +122,200 @@ int allocate_block(size_t req)
     }
     else if (alloc_type == BEST_FIT){
         size_t best = SIZE_MAX;
-        for (size_t i = 0; i < memory_blocks.size(); i++){
-            if (memory_blocks[i].free && memory_blocks[i].size >= aligned_req && memory_blocks[i].size < best){
-                best = memory_blocks[i].size;
+        for (size_t i = 0; i < blocks.size(); i++){
+            if (usable(blocks[i], aligned_req, node) && blocks[i].size < best){
+                best = blocks[i].size;
                 idx = i;
             }
         }
     }
     else{
         size_t worst = 0;
-        for (size_t i = 0; i < memory_blocks.size(); i++)
+        for (size_t i = 0; i < blocks.size(); i++)
         {
-            if (memory_blocks[i].free && memory_blocks[i].size >= aligned_req && memory_blocks[i].size > worst){
-                worst = memory_blocks[i].size;
+            if (usable(blocks[i], aligned_req, node) && blocks[i].size > worst){
+                worst = blocks[i].size;
                 idx = i;
             }
         }
     }
-    if(idx == -1){
-        failed_allocs++;
-        return -1;
-    }
-    Block old = memory_blocks[idx];
+    return idx;
+}
+
+// per-node arenas: try the policy's node first, then fall back to remote ones
+static int pick_block(const vector<Block> &blocks, size_t aligned_req, int node){
+    int idx = find_fit(blocks, aligned_req, numa_enabled() ? node : -1);
+    if (idx == -1 && numa_enabled() && get_numa_policy() != BIND)
+        idx = find_fit(blocks, aligned_req, -1);
+    return idx;
+}
+
+// turns free block idx into a used block of aligned_req bytes, splitting off the rest
+static void carve(vector<Block> &blocks, int idx, size_t aligned_req, size_t req, int id){
+    Block old = blocks[idx];
     if(old.size > aligned_req){
-        memory_blocks[idx] = {old.start,aligned_req,req,false,next_id++};
-        memory_blocks.insert(memory_blocks.begin()+idx+1,{old.start +aligned_req,old.size-aligned_req,0,true,-1});
+        blocks[idx] = {old.start,aligned_req,req,false,id};
+        blocks.insert(blocks.begin()+idx+1,{old.start +aligned_req,old.size-aligned_req,0,true,-1});
     }
     else{
-        memory_blocks[idx].free = false;
-        memory_blocks[idx].id = next_id++;
-        memory_blocks[idx].requested = req;
+        blocks[idx].free = false;
+        blocks[idx].id = id;
+        blocks[idx].requested = req;
+    }
+}
+
+// Compaction: live blocks slide down into the free block before them (never
+// across a NUMA arena boundary). Ids stay the same, only Block::start changes,
+// so memory_blocks itself is the id -> new address table.
+
+// swaps free block i with the used block after it, returns bytes moved
+static size_t slide_down(size_t i, bool verbose){
+    Block hole = memory_blocks[i];
+    Block live = memory_blocks[i + 1];
+    if (verbose) cout << "Moved id=" << live.id << ": " << live.start << " -> " << hole.start << "\n";
+    live.start = hole.start;
+    hole.start = live.start + live.size;
+    memory_blocks[i] = live;
+    memory_blocks[i + 1] = hole;
+    cstats.blocks_moved++;
+    cstats.bytes_moved += live.size;
+    return live.size;
+}
+
+// first free block followed by a movable used block in the same arena, -1 if none
+static int next_slide(size_t from){
+    for (size_t i = from; i + 1 < memory_blocks.size(); i++){
+        Block &hole = memory_blocks[i];
+        Block &live = memory_blocks[i + 1];
+        if (hole.free && !live.free && memory_node_of(hole.start) == memory_node_of(live.start))
+            return i;
+    }
+    return -1;
+}
+
+static void record_pause(chrono::steady_clock::time_point begin){
+    double us = chrono::duration<double, micro>(chrono::steady_clock::now() - begin).count();
+    cstats.pause_us += us;
+    cstats.max_pause_us = max(cstats.max_pause_us, us);
+}
+
+// full compaction, returns bytes moved
+size_t compact_memory(bool verbose){
+    auto begin = chrono::steady_clock::now();
+    size_t moved = 0;
+    int i = next_slide(0);
+    while (i != -1){
+        moved += slide_down(i, verbose);
+        coalesce(memory_blocks);
+        // the hole now sits at i + 1 (or merged further right), nothing before i changed
+        i = next_slide(i);
+    }
+    if (moved) cstats.runs++;
+    record_pause(begin);
+    return moved;
+}
+
+// background step run after every malloc/free. Each op adds compaction_budget
+// bytes of credit; a block bigger than what is left waits (its copy is in
+// progress) until enough credit has built up over later ops, so the amortized
+// cost stays at the budget while no hole is stranded behind a large block.
+static void compact_step(){
+    auto begin = chrono::steady_clock::now();
+    compaction_credit += compaction_budget;
+    bool moved = false;
+    int i = next_slide(0);
+    while (i != -1 && memory_blocks[i + 1].size <= compaction_credit){
+        compaction_credit -= slide_down(i, false);
+        moved = true;
+        coalesce(memory_blocks);
+        i = next_slide(i);
+    }
+    // nothing left to move, so do not bank budget for later
+    if (i == -1) compaction_credit = 0;
+    if (moved) cstats.runs++;
+    record_pause(begin);
+}
+
+void set_compaction(CompactionMode mode){
+    // the shadow layout starts from wherever memory is when compaction is switched on
+    if (compaction_mode == COMPACT_OFF && mode != COMPACT_OFF) shadow_blocks = memory_blocks;
+    compaction_mode = mode;
+    compaction_credit = 0;
+}
+
+void set_compaction_budget(size_t bytes){
+    compaction_budget = bytes;
+}
+
+// compaction only merges free space inside an arena, so it can only help if one
+// arena the request may use (just the bound node under BIND) has enough free in total
+static bool compaction_can_help(size_t aligned_req, int node){
+    vector<size_t> free_per_node(numa_node_count(), 0);
+    for (auto &b : memory_blocks)
+        if (b.free) free_per_node[memory_node_of(b.start)] += b.size;
+    if (numa_enabled() && get_numa_policy() == BIND) return free_per_node[node] >= aligned_req;
+    for (size_t f : free_per_node)
+        if (f >= aligned_req) return true;
+    return false;
+}
+
+int allocate_block(size_t req)
+{
+    total_alloc_requests++;
+    total_requested_memory += req;
+    size_t aligned_req = ((req + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT;
+
+    int node = numa_pick_node();
+    int idx = pick_block(memory_blocks, aligned_req, node);
+
+    // enough memory is free, it is just scattered: compact and retry
+    if (idx == -1 && compaction_mode == COMPACT_ON_FAILURE && compaction_can_help(aligned_req, node)){
+        compact_memory(false);
+        idx = pick_block(memory_blocks, aligned_req, node);
+    }
+
+    // replay on the non-moving layout; the id is the one this request gets if it succeeds
+    if (compaction_mode != COMPACT_OFF){
+        int shadow_idx = pick_block(shadow_blocks, aligned_req, node);
+        if (shadow_idx != -1) carve(shadow_blocks, shadow_idx, aligned_req, req, next_id);
+        if (idx != -1 && shadow_idx == -1) cstats.rescued_allocs++;
+        if (idx == -1 && shadow_idx != -1){
+            cstats.lost_allocs++;
+            // the real allocator never hands out this id, keep the shadow from reusing it
+            shadow_blocks[shadow_idx].id = -2;
+        }
+    }
+
+    if(idx == -1){
+        failed_allocs++;
+        if (compaction_mode == COMPACT_INCREMENTAL) compact_step();
+        return -1;
     }
+    carve(memory_blocks, idx, aligned_req, req, next_id++);
+    int placed = memory_node_of(memory_blocks[idx].start);
+    numa_record_alloc(placed, placed == node);
     successful_allocs++;
     total_allocated_memory += aligned_req;
     total_internal_fragmentation += (aligned_req - req);
-    return memory_blocks[idx].id;
+    int id = memory_blocks[idx].id;
+    if (compaction_mode == COMPACT_INCREMENTAL) compact_step();
+    return id;
 }
 
 // Deallocation
 
+static void shadow_free(int id){
+    for (auto &b : shadow_blocks){
+        if (!b.free && b.id == id){
+            b.free = true;
+            b.id = -1;
+            b.requested = 0;
+            coalesce(shadow_blocks);
+            return;
+        }
+    }
+}
+
 bool free_block(int id)
 {
     for (auto &b : memory_blocks){
@@ -115,7 +325,9 @@ bool free_block(int id)
             b.free = true;
             b.id = -1;
             b.requested = 0;
-            coalesce();
+            coalesce(memory_blocks);
+            if (compaction_mode != COMPACT_OFF) shadow_free(id);
+            if (compaction_mode == COMPACT_INCREMENTAL) compact_step();
             return true;
         }
     }
@@ -129,6 +341,7 @@ void dump_memory() {
         size_t start = b.start;
         size_t end = b.start + b.size - 1;
         cout << "[" << start << " - " << end << "] "<< "(0x" << hex << start << " - 0x" << end << dec << ") ";
+        if (numa_enabled()) cout << "node " << memory_node_of(start) << " ";
         if (b.free) cout << "FREE\n";
         else cout << "USED (id=" << b.id << ")\n";
     }
@@ -168,3 +381,95 @@ void print_stats(){
     cout<<"Failed allocations: "<<failed_allocs<<"\n";
     cout<<"Memory utilization: "<<fixed<<setprecision(2)<<utilization<<"%\n";
 }
+
+void print_compaction_stats(){
+    static const char *mode_names[] = {"off", "on_failure", "incremental"};
+    double success_rate = 0.0, base_rate = 0.0;
+    if (total_alloc_requests > 0){
+        success_rate = (double)successful_allocs / total_alloc_requests * 100;
+        base_rate = (double)(successful_allocs - cstats.rescued_allocs + cstats.lost_allocs) / total_alloc_requests * 100;
+    }
+    cout << "Compaction mode: " << mode_names[compaction_mode];
+    if (compaction_mode == COMPACT_INCREMENTAL) cout << " (budget " << compaction_budget << " bytes/op)";
+    cout << "\n";
+    cout << "Compaction runs: " << cstats.runs << "\n";
+    if (compaction_mode == COMPACT_INCREMENTAL) cout << "Carried budget: " << compaction_credit << " bytes\n";
+    cout << "Blocks moved: " << cstats.blocks_moved << "\n";
+    cout << "Bytes moved: " << cstats.bytes_moved << "\n";
+    cout << "Pause time: " << fixed << setprecision(2) << cstats.pause_us << " us (max " << cstats.max_pause_us << " us)\n";
+    cout << "Allocations rescued: " << cstats.rescued_allocs << "\n";
+    cout << "Allocations lost: " << cstats.lost_allocs << "\n";
+    cout << "Success rate without compaction: " << fixed << setprecision(2) << base_rate << "%\n";
+    cout << "Success rate with compaction: " << fixed << setprecision(2) << success_rate << "%\n";
+}
+
+// Snapshot
+
+void save_allocator_state(ostream &out){
+    snap_write(out, (uint64_t)TOTAL_MEMORY);
+    snap_write(out, alloc_type);
+    snap_write(out, next_id);
+    snap_write(out, (uint64_t)total_alloc_requests);
+    snap_write(out, (uint64_t)successful_allocs);
+    snap_write(out, (uint64_t)failed_allocs);
+    snap_write(out, (uint64_t)total_requested_memory);
+    snap_write(out, (uint64_t)total_allocated_memory);
+    snap_write(out, (uint64_t)total_internal_fragmentation);
+    snap_write_vec(out, memory_blocks);
+    snap_write(out, compaction_mode);
+    snap_write(out, (uint64_t)compaction_budget);
+    snap_write(out, (uint64_t)compaction_credit);
+    snap_write(out, cstats);
+    snap_write_vec(out, shadow_blocks);
+}
+
+// blocks must tile [0, total) in address order, used blocks holding no more than their size
+static bool valid_layout(const vector<Block> &blocks, size_t total){
+    size_t at = 0;
+    for (auto &b : blocks){
+        if (b.start != at || b.size == 0 || b.size > total - at) return false;
+        if (!b.free && b.requested > b.size) return false;
+        at += b.size;
+    }
+    return at == total;
+}
+
+bool load_allocator_state(istream &in){
+    uint64_t total, requests, ok, failed, requested, allocated, internal;
+    int32_t type;
+    int id;
+    vector<Block> blocks;
+    if (!snap_read(in, total) || !snap_read(in, type) || !snap_read(in, id) ||
+        !snap_read(in, requests) || !snap_read(in, ok) || !snap_read(in, failed) ||
+        !snap_read(in, requested) || !snap_read(in, allocated) || !snap_read(in, internal) ||
+        !snap_read_vec(in, blocks))
+        return false;
+    int32_t mode;
+    uint64_t budget, credit;
+    CompactionStats stats;
+    vector<Block> shadow;
+    if (!snap_read(in, mode) || !snap_read(in, budget) || !snap_read(in, credit) ||
+        !snap_read(in, stats) || !snap_read_vec(in, shadow))
+        return false;
+    if (type < FIRST_FIT || type > WORST_FIT || mode < COMPACT_OFF || mode > COMPACT_INCREMENTAL)
+        return false;
+    if (!valid_layout(blocks, total) || (!shadow.empty() && !valid_layout(shadow, total)))
+        return false;
+
+    TOTAL_MEMORY = total;
+    alloc_type = (AllocatorType)type;
+    next_id = id;
+    total_alloc_requests = requests;
+    successful_allocs = ok;
+    failed_allocs = failed;
+    total_requested_memory = requested;
+    total_allocated_memory = allocated;
+    total_internal_fragmentation = internal;
+    memory_blocks = move(blocks);
+    compaction_mode = (CompactionMode)mode;
+    compaction_budget = budget;
+    compaction_credit = credit;
+    cstats = stats;
+    shadow_blocks = move(shadow);
+    return true;
+}
@@ -106,3 +106,73 @@ void dump_buddy(){
         cout << "\n";
     }
 }
+
+// Snapshot
+
+void save_buddy_state(ostream &out){
+    snap_write(out, (uint64_t)BUDDY_MEMORY_SIZE);
+    snap_write(out, (uint64_t)buddy_internal_frag);
+    snap_write(out, buddy_next_id);
+
+    // only non-empty lists are worth storing, buddy_malloc recreates the rest on demand
+    uint64_t lists = 0;
+    for (auto &p : free_lists)
+        if (!p.second.empty()) lists++;
+    snap_write(out, lists);
+    for (auto &p : free_lists){
+        if (p.second.empty()) continue;
+        vector<size_t> addrs(p.second.begin(), p.second.end());
+        snap_write(out, (uint64_t)p.first);
+        snap_write_vec(out, addrs);
+    }
+
+    snap_write(out, (uint64_t)allocated.size());
+    for (auto &p : allocated){
+        snap_write(out, p.first);
+        snap_write(out, (uint64_t)get<0>(p.second));
+        snap_write(out, (uint64_t)get<1>(p.second));
+        snap_write(out, (uint64_t)get<2>(p.second));
+    }
+}
+
+// a block must be a power-of-two size, aligned to it and inside memory
+static bool buddy_block_ok(size_t addr, size_t block_size, size_t mem_size){
+    return is_power_of_two(block_size) && block_size <= mem_size &&
+           addr % block_size == 0 && addr <= mem_size - block_size;
+}
+
+bool load_buddy_state(istream &in){
+    uint64_t mem_size, frag, lists, count;
+    int id;
+    if (!snap_read(in, mem_size) || !snap_read(in, frag) || !snap_read(in, id) || !snap_read(in, lists))
+        return false;
+    if (mem_size != 0 && !is_power_of_two(mem_size)) return false;
+
+    unordered_map<size_t, set<size_t>> new_free;
+    for (uint64_t i = 0; i < lists; i++){
+        uint64_t block_size;
+        vector<size_t> addrs;
+        if (!snap_read(in, block_size) || !snap_read_vec(in, addrs)) return false;
+        for (size_t addr : addrs)
+            if (!buddy_block_ok(addr, block_size, mem_size)) return false;
+        new_free[block_size].insert(addrs.begin(), addrs.end());
+    }
+
+    unordered_map<int, tuple<size_t, size_t, size_t>> new_alloc;
+    if (!snap_read(in, count)) return false;
+    for (uint64_t i = 0; i < count; i++){
+        int key;
+        uint64_t addr, block_size, req_size;
+        if (!snap_read(in, key) || !snap_read(in, addr) || !snap_read(in, block_size) || !snap_read(in, req_size))
+            return false;
+        if (!buddy_block_ok(addr, block_size, mem_size) || req_size > block_size) return false;
+        new_alloc[key] = make_tuple(addr, block_size, req_size);
+    }
+
+    BUDDY_MEMORY_SIZE = mem_size;
+    buddy_internal_frag = frag;
+    buddy_next_id = id;
+    free_lists = move(new_free);
+    allocated = move(new_alloc);
+    return true;
+}
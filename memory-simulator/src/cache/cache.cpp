@@ -22,12 +22,9 @@ void init_cache(Cache &c, string name,size_t cache_size,size_t block_size,size_t
     // allocate cache sets
     c.sets.assign(c.num_sets, vector<CacheLine>(associativity));
 }
-// When we will access this cachee with given address then it will Returns true on HIT, false on MISS
-
-bool access_cache(Cache &c, size_t address){
-    c.time++;
-    c.accesses++;
+// Lookup + fill shared by detailed and warming accesses, returns true on HIT
 
+static bool lookup_and_fill(Cache &c, size_t address){
 // block address, set index, and tag
     size_t block = address / c.block_size;
     size_t set_id = block % c.num_sets;
@@ -38,13 +35,11 @@ bool access_cache(Cache &c, size_t address){
     {
         if (line.valid && line.tag == tag)
         {
-            c.hits++;
             if (c.policy == LRU)
                 line.timestamp = c.time;
             return true;
         }
     }
-    c.misses++;
 
     // place in empty line if available
     for (auto &line : set){
@@ -62,6 +57,24 @@ bool access_cache(Cache &c, size_t address){
     return false;
 }
 
+// When we will access this cachee with given address then it will Returns true on HIT, false on MISS
+
+bool access_cache(Cache &c, size_t address){
+    c.time++;
+    c.accesses++;
+    bool hit = lookup_and_fill(c, address);
+    if (hit) c.hits++;
+    else c.misses++;
+    return hit;
+}
+
+// Functional warming: same state update as access_cache but stats are untouched
+
+bool warm_cache(Cache &c, size_t address){
+    c.time++;
+    return lookup_and_fill(c, address);
+}
+
 // Cachee Stats
 void print_cache_stats(const Cache &c){
     size_t total = c.hits + c.misses;
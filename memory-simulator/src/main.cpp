@@ -23,6 +23,115 @@ enum AllocMode{
 };
 
 static AllocMode alloc_mode = NORMAL;
+
+// L1 -> L2 -> L3 -> memory walk, returns the level that served the access (4 = memory)
+
+static int hierarchy_access(size_t addr, int node, bool verbose){
+    size_t access_time = 0;
+    int level;
+    total_memory_accesses++;
+
+    bool l1_hit = access_cache(L1, addr);
+    if (l1_hit)
+    {
+        if (verbose) cout << "L1 HIT\n";
+        access_time += L1_LATENCY;
+        level = 1;
+    }
+    else
+    {
+        l1_miss_to_l2++;
+        access_time += L1_LATENCY;
+
+        bool l2_hit = access_cache(L2, addr);
+        if (l2_hit)
+        {
+            if (verbose) cout << "L1 MISS -> L2 HIT\n";
+            access_time += L2_LATENCY;
+            level = 2;
+        }
+        else
+        {
+            l2_miss_to_l3++;
+            access_time += L2_LATENCY;
+
+            bool l3_hit = access_cache(L3, addr);
+            if (l3_hit)
+            {
+                if (verbose) cout << "L1 MISS -> L2 MISS -> L3 HIT\n";
+                access_time += L3_LATENCY;
+                level = 3;
+            }
+            else
+            {
+                l3_miss_to_memory++;
+                if (verbose) cout << "L1 MISS -> L2 MISS -> L3 MISS -> MEMORY\n";
+                access_time += L3_LATENCY;
+                access_time += numa_memory_latency(node, MEMORY_LATENCY);
+                level = 4;
+            }
+        }
+    }
+
+    total_access_time += access_time;
+    return level;
+}
+
+// Sampled mode: most accesses are skipped, a bounded warm-up before each
+// detailed window only updates state, the window itself is measured
+
+static void sampled_access(size_t addr, bool is_virtual){
+    SampleAction action = sample_next(is_virtual);
+    if (action == SAMPLE_SKIP) return;
+    if (action == SAMPLE_WARM)
+    {
+        size_t paddr = is_virtual ? warm_translate(addr) : addr;
+        if (!warm_cache(L1, paddr) && !warm_cache(L2, paddr))
+            warm_cache(L3, paddr);
+        return;
+    }
+    size_t faults = get_page_faults();
+    size_t paddr = is_virtual ? translate_address(addr) : addr;
+    size_t time_before = total_access_time;
+    int node = is_virtual ? vm_node_of(paddr) : memory_node_of(paddr);
+    int level = hierarchy_access(paddr, node, false);
+    sample_record(total_access_time - time_before, level, is_virtual, get_page_faults() != faults);
+}
+
+// Generated workloads stream straight into the simulator without per-op output
+
+static vector<int> gen_ids;   // generator handle -> allocator id (-1 if that malloc failed)
+
+static void run_workload_batch(const vector<WorkOp> &ops){
+    for (auto &op : ops)
+    {
+        if (op.kind == OP_ACCESS)
+        {
+            if (sampling_enabled()) sampled_access(op.value, false);
+            else hierarchy_access(op.value, memory_node_of(op.value), false);
+        }
+        else if (op.kind == OP_VM_ACCESS)
+        {
+            if (sampling_enabled()) sampled_access(op.value, true);
+            else
+            {
+                size_t paddr = translate_address(op.value);
+                hierarchy_access(paddr, vm_node_of(paddr), false);
+            }
+        }
+        else if (op.kind == OP_MALLOC)
+        {
+            gen_ids.push_back(alloc_mode == BUDDY ? buddy_malloc(op.value) : allocate_block(op.value));
+        }
+        else
+        {
+            int id = gen_ids[op.value];
+            if (id == -1) continue;
+            if (alloc_mode == BUDDY) buddy_free(id);
+            else free_block(id);
+        }
+    }
+}
 int main(){
     cout << "Hello......Welcome to Memory Simulator built by - Aryan\n";
     init_cache(L1, "L1", 64, 16, 1, LRU);
@@ -62,6 +171,37 @@ int main(){
                 if (value == "fifo") set_vm_policy(FIFO_VM);
                 else if (value == "lru") set_vm_policy(LRU_VM);
             }
+            else if (what == "numa_policy")
+            {
+                if (value == "first_touch") set_numa_policy(FIRST_TOUCH);
+                else if (value == "interleave") set_numa_policy(INTERLEAVE);
+                else if (value == "bind") set_numa_policy(BIND);
+                else if (value == "migrate") set_numa_policy(MIGRATE_ON_HOT);
+            }
+            else if (what == "cpu_node" || what == "numa_bind" || what == "numa_hot")
+            {
+                size_t n;
+                if (!parse_size(value, n)) cout << "nahh....Invalid number\n";
+                else if (what == "numa_hot") set_numa_hot_threshold(n);
+                else
+                {
+                    int node = (int)min(n, (size_t)INT_MAX);
+                    if (what == "cpu_node") set_cpu_node(node);
+                    else set_numa_bind(node);
+                }
+            }
+            else if (what == "compaction")
+            {
+                if (value == "off") set_compaction(COMPACT_OFF);
+                else if (value == "on_failure") set_compaction(COMPACT_ON_FAILURE);
+                else if (value == "incremental") set_compaction(COMPACT_INCREMENTAL);
+            }
+            else if (what == "compaction_budget")
+            {
+                size_t bytes;
+                if (parse_size(value, bytes)) set_compaction_budget(bytes);
+                else cout << "nahh....Invalid number\n";
+            }
         }
         else if (cmd == "malloc")
         {
@@ -93,55 +233,20 @@ int main(){
             if (alloc_mode == BUDDY) print_buddy_stats();
             else print_stats();
         }
+        else if (cmd == "compact")
+        {
+            size_t moved = compact_memory(true);
+            cout << "Compacted, " << moved << " bytes moved\n";
+        }
+        else if (cmd == "compaction_stats"){ print_compaction_stats();}
 
 //    Cachee
         else if (cmd == "access")
         {
             size_t addr;
             cin >> addr;
-            size_t access_time = 0;
-            total_memory_accesses++;
-
-            bool l1_hit = access_cache(L1, addr);
-
-            if (l1_hit)
-            {
-                cout << "L1 HIT\n";
-                access_time += L1_LATENCY;
-            }
-            else
-            {
-                l1_miss_to_l2++;
-                access_time += L1_LATENCY;
-
-                bool l2_hit = access_cache(L2, addr);
-                if (l2_hit)
-                {
-                    cout << "L1 MISS -> L2 HIT\n";
-                    access_time += L2_LATENCY;
-                }
-                else
-                {
-                    l2_miss_to_l3++;
-                    access_time += L2_LATENCY;
-
-                    bool l3_hit = access_cache(L3, addr);
-                    if (l3_hit)
-                    {
-                        cout << "L1 MISS -> L2 MISS -> L3 HIT\n";
-                        access_time += L3_LATENCY;
-                    }
-                    else
-                    {
-                        l3_miss_to_memory++;
-                        cout << "L1 MISS -> L2 MISS -> L3 MISS -> MEMORY\n";
-                        access_time += L3_LATENCY;
-                        access_time += MEMORY_LATENCY;
-                    }
-                }
-            }
-
-            total_access_time += access_time;
+            if (sampling_enabled()) sampled_access(addr, false);
+            else hierarchy_access(addr, memory_node_of(addr), true);
         }
 
 //  Virtual Memory 
@@ -154,45 +259,12 @@ int main(){
         {
             size_t vaddr;
             cin >> vaddr;
-            size_t paddr = translate_address(vaddr);
-            size_t access_time = 0;
-            total_memory_accesses++;
-            bool l1_hit = access_cache(L1, paddr);
-            if (l1_hit)
-            {
-                cout << "L1 HIT\n";
-                access_time += L1_LATENCY;
-            }
+            if (sampling_enabled()) sampled_access(vaddr, true);
             else
             {
-                l1_miss_to_l2++;
-                access_time += L1_LATENCY;
-                bool l2_hit = access_cache(L2, paddr);
-                if (l2_hit)
-                {
-                    cout << "L1 MISS -> L2 HIT\n";
-                    access_time += L2_LATENCY;
-                }
-                else
-                {
-                    l2_miss_to_l3++;
-                    access_time += L2_LATENCY;
-                    bool l3_hit = access_cache(L3, paddr);
-                    if (l3_hit)
-                    {
-                        cout << "L1 MISS -> L2 MISS -> L3 HIT\n";
-                        access_time += L3_LATENCY;
-                    }
-                    else
-                    {
-                        l3_miss_to_memory++;
-                        cout << "L1 MISS -> L2 MISS -> L3 MISS -> MEMORY\n";
-                        access_time += L3_LATENCY;
-                        access_time += MEMORY_LATENCY;
-                    }
-                }
+                size_t paddr = translate_address(vaddr);
+                hierarchy_access(paddr, vm_node_of(paddr), true);
             }
-            total_access_time += access_time;
         }
         else if (cmd == "cache_stats")
         {
@@ -201,6 +273,92 @@ int main(){
             print_cache_stats(L3);
         }
         else if (cmd == "vm_stats"){ print_vm_stats();}
+
+//  Sampling
+        else if (cmd == "sample")
+        {
+            string what;
+            cin >> what;
+            if (what == "off") set_sampling(0, 0, 0);
+            else
+            {
+                string window_s, warmup_s;
+                size_t period, window, warmup;
+                cin >> window_s >> warmup_s;
+                if (parse_size(what, period) && parse_size(window_s, window) && parse_size(warmup_s, warmup))
+                    set_sampling(period, window, warmup);
+                else cout << "nahh....Invalid sampling arguments\n";
+            }
+        }
+        else if (cmd == "sample_stats"){ print_sample_stats();}
+
+//  NUMA
+        else if (cmd == "init_numa")
+        {
+            string nodes_s, local_s, remote_s;
+            size_t nodes, local_latency, remote_latency;
+            cin >> nodes_s >> local_s >> remote_s;
+            if (parse_size(nodes_s, nodes) && parse_size(local_s, local_latency) && parse_size(remote_s, remote_latency))
+                init_numa(nodes, local_latency, remote_latency);
+            else cout << "nahh....Invalid NUMA arguments\n";
+        }
+        else if (cmd == "numa_latency")
+        {
+            string node_s, local_s, remote_s;
+            size_t node, local_latency, remote_latency;
+            cin >> node_s >> local_s >> remote_s;
+            if (parse_size(node_s, node) && parse_size(local_s, local_latency) && parse_size(remote_s, remote_latency))
+                set_numa_latency(node < numa_node_count() ? (int)node : -1, local_latency, remote_latency);
+            else cout << "nahh....Invalid NUMA arguments\n";
+        }
+        else if (cmd == "numa_stats"){ print_numa_stats();}
+
+//  Workload generator
+        else if (cmd == "gen_param")
+        {
+            string key, value;
+            cin >> key >> value;
+            if (!set_workload_param(key, value)) cout << "nahh....Invalid generator parameter\n";
+        }
+        else if (cmd == "gen")
+        {
+            string pattern, count_s, seed_s;
+            size_t count, seed;
+            cin >> pattern >> count_s >> seed_s;
+            gen_ids.clear();
+            if (!parse_size(count_s, count) || !parse_size(seed_s, seed))
+                cout << "nahh....Invalid count or seed\n";
+            else if (generate_workload(pattern, count, seed, run_workload_batch))
+                cout << "Generated " << count << " ops (" << pattern << ")\n";
+            else cout << "nahh....Unknown pattern\n";
+        }
+        else if (cmd == "gen_trace")
+        {
+            string path, pattern, count_s, seed_s;
+            size_t count, seed;
+            cin >> path >> pattern >> count_s >> seed_s;
+            if (!parse_size(count_s, count) || !parse_size(seed_s, seed))
+                cout << "nahh....Invalid count or seed\n";
+            else if (write_workload_trace(path, pattern, count, seed))
+                cout << "Wrote " << count << " ops (" << pattern << ") to " << path << "\n";
+            else cout << "nahh....Trace generation failed\n";
+        }
+
+//  Snapshot
+        else if (cmd == "save")
+        {
+            string path;
+            cin >> path;
+            if (save_snapshot(path)) cout << "Snapshot saved to " << path << "\n";
+            else cout << "nahh....Snapshot save failed\n";
+        }
+        else if (cmd == "load")
+        {
+            string path;
+            cin >> path;
+            if (load_snapshot(path)) cout << "Snapshot restored from " << path << "\n";
+            else cout << "nahh....Snapshot load failed\n";
+        }
         else if (cmd == "dump_vm") { dump_page_table();}
         else if (cmd == "exit"){  break;}
         // andi_bandi_s--;
@@ -0,0 +1,225 @@
+#include "../../include/memsim.h"
+
+// NUMA model: physical frames (VM) and allocator memory are each split into
+// `numa_nodes` contiguous pools. The simulated CPU runs on `cpu_node`; memory
+// on any other node is remote and pays that node's remote latency.
+
+struct NumaNode
+{
+    size_t local_latency = 0;
+    size_t remote_latency = 0;
+
+    size_t local_accesses = 0;
+    size_t remote_accesses = 0;
+    size_t latency = 0;           // memory cycles spent on this node
+    size_t remote_penalty = 0;    // cycles above what the accessing cpu node's local memory costs
+    size_t pages_placed = 0;
+    size_t pages_migrated_in = 0;
+    size_t local_allocs = 0;
+    size_t remote_allocs = 0;     // allocations that fell back to this node
+};
+
+static vector<NumaNode> numa_nodes;
+static NumaPolicy numa_policy = FIRST_TOUCH;
+static int cpu_node = 0;
+static int bind_node = 0;
+static size_t hot_threshold = 4;
+static size_t interleave_next = 0;
+
+static const size_t MAX_NUMA_NODES = 64;
+
+// Initialize
+
+void init_numa(size_t nodes, size_t local_latency, size_t remote_latency){
+    if (nodes == 0 || nodes > MAX_NUMA_NODES){
+        cout << "NUMA needs 1 to " << MAX_NUMA_NODES << " nodes\n";
+        return;
+    }
+    NumaNode n;
+    n.local_latency = local_latency;
+    n.remote_latency = remote_latency;
+    numa_nodes.assign(nodes, n);
+    cpu_node = 0;
+    bind_node = 0;
+    interleave_next = 0;
+
+    // free allocator blocks must not straddle node boundaries, blocks
+    // allocated now are cut when they are freed
+    split_free_at_arenas();
+}
+
+bool numa_enabled(){
+    return numa_nodes.size() > 1;
+}
+
+size_t numa_node_count(){
+    return numa_enabled() ? numa_nodes.size() : 1;
+}
+
+void set_numa_latency(int node, size_t local_latency, size_t remote_latency){
+    if (node < 0 || node >= (int)numa_nodes.size()){
+        cout << "Invalid NUMA node\n";
+        return;
+    }
+    numa_nodes[node].local_latency = local_latency;
+    numa_nodes[node].remote_latency = remote_latency;
+}
+
+void set_numa_policy(NumaPolicy p){
+    numa_policy = p;
+}
+
+NumaPolicy get_numa_policy(){
+    return numa_policy;
+}
+
+void set_cpu_node(int node){
+    if (node < 0 || node >= (int)numa_node_count()){
+        cout << "Invalid NUMA node\n";
+        return;
+    }
+    cpu_node = node;
+}
+
+int get_cpu_node(){
+    return cpu_node;
+}
+
+void set_numa_bind(int node){
+    if (node < 0 || node >= (int)numa_node_count()){
+        cout << "Invalid NUMA node\n";
+        return;
+    }
+    bind_node = node;
+    numa_policy = BIND;
+}
+
+void set_numa_hot_threshold(size_t accesses){
+    hot_threshold = max(accesses, (size_t)1);
+}
+
+size_t numa_hot_threshold(){
+    return hot_threshold;
+}
+
+// Pool layout: index i of `count` units belongs to node i * nodes / count
+
+int numa_node_of(size_t index, size_t count){
+    size_t nodes = numa_node_count();
+    if (nodes == 1 || count == 0) return 0;
+    return (int)min(index * nodes / count, nodes - 1);
+}
+
+size_t numa_range_start(int node, size_t count){
+    size_t nodes = numa_node_count();
+    return ((size_t)node * count + nodes - 1) / nodes;
+}
+
+// Placement policy: node that new memory should come from
+
+int numa_pick_node(){
+    if (!numa_enabled()) return 0;
+    if (numa_policy == INTERLEAVE) return (int)(interleave_next++ % numa_nodes.size());
+    if (numa_policy == BIND) return bind_node;
+    return cpu_node;   // first touch and migrate-on-hot both start local
+}
+
+// Latency
+
+size_t numa_memory_latency(int node, size_t default_latency){
+    if (!numa_enabled()) return default_latency;
+    NumaNode &n = numa_nodes[node];
+    size_t lat;
+    if (node == cpu_node){
+        n.local_accesses++;
+        lat = n.local_latency;
+    }
+    else{
+        n.remote_accesses++;
+        lat = n.remote_latency;
+        size_t local = numa_nodes[cpu_node].local_latency;
+        if (lat > local) n.remote_penalty += lat - local;
+    }
+    n.latency += lat;
+    return lat;
+}
+
+// Event counters fed by the VM and allocator
+
+void numa_record_placement(int node){
+    if (numa_enabled()) numa_nodes[node].pages_placed++;
+}
+
+void numa_record_migration(int node){
+    if (numa_enabled()) numa_nodes[node].pages_migrated_in++;
+}
+
+void numa_record_alloc(int node, bool local){
+    if (!numa_enabled()) return;
+    if (local) numa_nodes[node].local_allocs++;
+    else numa_nodes[node].remote_allocs++;
+}
+
+// Stats
+
+void print_numa_stats(){
+    if (!numa_enabled()){
+        cout << "NUMA is off\n";
+        return;
+    }
+    static const char *policy_names[] = {"first_touch", "interleave", "bind", "migrate"};
+    cout << "NUMA nodes: " << numa_nodes.size() << " (policy " << policy_names[numa_policy] << ", cpu node " << cpu_node << ")\n";
+
+    size_t local = 0, remote = 0, latency = 0, penalty = 0;
+    for (size_t i = 0; i < numa_nodes.size(); i++){
+        NumaNode &n = numa_nodes[i];
+        cout << "Node " << i << ": local " << n.local_accesses << ", remote " << n.remote_accesses
+             << ", latency " << n.latency << ", pages placed " << n.pages_placed
+             << ", migrated in " << n.pages_migrated_in << ", allocs " << n.local_allocs
+             << " local / " << n.remote_allocs << " fallback\n";
+        local += n.local_accesses;
+        remote += n.remote_accesses;
+        latency += n.latency;
+        penalty += n.remote_penalty;
+    }
+    size_t total = local + remote;
+    double remote_ratio = total ? (double)remote / total * 100 : 0.0;
+    cout << "Local accesses: " << local << "\n";
+    cout << "Remote accesses: " << remote << "\n";
+    cout << "Remote ratio: " << fixed << setprecision(2) << remote_ratio << "%\n";
+    cout << "Memory latency: " << latency << "\n";
+    cout << "Remote latency penalty: " << penalty << "\n";
+}
+
+// Snapshot
+
+void save_numa_state(ostream &out){
+    snap_write_vec(out, numa_nodes);
+    snap_write(out, numa_policy);
+    snap_write(out, cpu_node);
+    snap_write(out, bind_node);
+    snap_write(out, (uint64_t)hot_threshold);
+    snap_write(out, (uint64_t)interleave_next);
+}
+
+bool load_numa_state(istream &in){
+    vector<NumaNode> nodes;
+    int32_t policy;
+    int cpu, bind;
+    uint64_t hot, next;
+    if (!snap_read_vec(in, nodes) || !snap_read(in, policy) || !snap_read(in, cpu) ||
+        !snap_read(in, bind) || !snap_read(in, hot) || !snap_read(in, next))
+        return false;
+    if (nodes.size() > MAX_NUMA_NODES) return false;
+    int count = nodes.size() > 1 ? (int)nodes.size() : 1;
+    if (policy < FIRST_TOUCH || policy > MIGRATE_ON_HOT || cpu < 0 || cpu >= count ||
+        bind < 0 || bind >= count || hot == 0)
+        return false;
+    numa_nodes = move(nodes);
+    numa_policy = (NumaPolicy)policy;
+    cpu_node = cpu;
+    bind_node = bind;
+    hot_threshold = hot;
+    interleave_next = next;
+    return true;
+}
@@ -0,0 +1,215 @@
+#include "../../include/memsim.h"
+
+// Systematic sampling: every `period` accesses the last `window` are simulated
+// in detail and the `warmup` accesses before them only update cache / page
+// state. Everything else in the period is skipped outright, which is where the
+// speedup comes from. Per-window measurements give the estimates and their 95%
+// confidence intervals; comparing the two halves of each window shows how much
+// cold state the warm-up left behind.
+
+struct SampleWindow
+{
+    size_t accesses = 0;
+    size_t latency = 0;
+    size_t l1_hits = 0;
+    size_t l2_lookups = 0;
+    size_t l2_hits = 0;
+    size_t l3_lookups = 0;
+    size_t l3_hits = 0;
+    size_t vm_accesses = 0;
+    size_t faults = 0;
+    size_t head_accesses = 0;     // first half of the window, for the warm-up bias
+    size_t head_latency = 0;
+};
+
+static size_t sample_period = 0;
+static size_t sample_window = 0;
+static size_t sample_warmup = 0;
+static size_t sample_pos = 0;       // accesses seen (skipped + warmed + detailed)
+static size_t sample_warmed = 0;
+static size_t sample_vm_total = 0;  // vm accesses seen
+static vector<SampleWindow> windows;
+
+static const double Z_95 = 1.96;
+
+void set_sampling(size_t period, size_t window, size_t warmup){
+    if (period != 0 && (window == 0 || window > period || warmup > period - window)){
+        cout << "Invalid sampling configuration\n";
+        period = 0;
+    }
+    sample_period = period;
+    sample_window = period ? window : 0;
+    sample_warmup = period ? warmup : 0;
+    sample_pos = 0;
+    sample_warmed = 0;
+    sample_vm_total = 0;
+    windows.clear();
+}
+
+bool sampling_enabled(){
+    return sample_period != 0;
+}
+
+// advances the sampler by one access and says how much of it to simulate
+SampleAction sample_next(bool is_virtual){
+    if (is_virtual) sample_vm_total++;
+    size_t phase = sample_pos++ % sample_period;
+    size_t detail_start = sample_period - sample_window;
+    if (phase < detail_start - sample_warmup) return SAMPLE_SKIP;
+    if (phase < detail_start){
+        sample_warmed++;
+        return SAMPLE_WARM;
+    }
+    if (phase == detail_start) windows.push_back(SampleWindow());
+    return SAMPLE_DETAIL;
+}
+
+void sample_record(size_t latency, int level, bool is_virtual, bool fault){
+    SampleWindow &w = windows.back();
+    if (w.accesses < sample_window / 2){
+        w.head_accesses++;
+        w.head_latency += latency;
+    }
+    w.accesses++;
+    w.latency += latency;
+    if (level == 1) w.l1_hits++;
+    if (level >= 2) w.l2_lookups++;
+    if (level == 2) w.l2_hits++;
+    if (level >= 3) w.l3_lookups++;
+    if (level == 3) w.l3_hits++;
+    if (is_virtual){
+        w.vm_accesses++;
+        if (fault) w.faults++;
+    }
+}
+
+// ratio estimator sum(num)/sum(den) with its 95% confidence half-width,
+// ci is negative when fewer than two windows leave nothing to estimate it from
+static bool ratio_estimate(size_t SampleWindow::*num, size_t SampleWindow::*den, double &r, double &ci){
+    double sum_num = 0, sum_den = 0;
+    size_t n = 0;
+    for (auto &w : windows){
+        if (w.*den == 0) continue;
+        sum_num += w.*num;
+        sum_den += w.*den;
+        n++;
+    }
+    if (sum_den == 0) return false;
+    r = sum_num / sum_den;
+    ci = -1.0;
+    if (n < 2) return true;
+
+    double sq = 0;
+    for (auto &w : windows){
+        if (w.*den == 0) continue;
+        double d = w.*num - r * w.*den;
+        sq += d * d;
+    }
+    // finite population correction, a fully detailed run has no sampling error
+    double fpc = 1.0 - (double)windows.size() * sample_window / max(sample_pos, (size_t)1);
+    double mean_den = sum_den / n;
+    ci = Z_95 * sqrt(max(fpc, 0.0) * sq / (n * (n - 1.0))) / mean_den;
+    return true;
+}
+
+static void print_interval(double ci, double scale){
+    if (ci < 0) cout << "n/a (insufficient windows)";
+    else cout << ci * scale;
+}
+
+static void print_estimate(const string &label, size_t SampleWindow::*num, size_t SampleWindow::*den, double scale){
+    double r, ci;
+    cout << label << ": ";
+    if (!ratio_estimate(num, den, r, ci)){
+        cout << "n/a\n";
+        return;
+    }
+    cout << fixed << setprecision(2) << r * scale << " +/- ";
+    print_interval(ci, scale);
+    if (r > 0 && ci >= 0) cout << " (" << ci / r * 100 << "% rel. error)";
+    cout << "\n";
+}
+
+void print_sample_stats(){
+    if (!sampling_enabled()){
+        cout << "Sampling is off\n";
+        return;
+    }
+    size_t detailed = 0;
+    for (auto &w : windows) detailed += w.accesses;
+
+    cout << "Sampled windows: " << windows.size() << "\n";
+    cout << "Detailed accesses: " << detailed << " of " << sample_pos << "\n";
+    cout << "Warmed accesses: " << sample_warmed << " (" << sample_warmup << " before each window)\n";
+    cout << "Skipped accesses: " << sample_pos - detailed - sample_warmed << "\n";
+    print_estimate("Avg access time", &SampleWindow::latency, &SampleWindow::accesses, 1.0);
+
+    double r, ci;
+    if (ratio_estimate(&SampleWindow::latency, &SampleWindow::accesses, r, ci)){
+        cout << "Est. total access time: " << fixed << setprecision(0) << r * sample_pos << " +/- ";
+        print_interval(ci, sample_pos);
+        cout << "\n";
+    }
+
+    print_estimate("L1 hit ratio (%)", &SampleWindow::l1_hits, &SampleWindow::accesses, 100.0);
+    print_estimate("L2 hit ratio (%)", &SampleWindow::l2_hits, &SampleWindow::l2_lookups, 100.0);
+    print_estimate("L3 hit ratio (%)", &SampleWindow::l3_hits, &SampleWindow::l3_lookups, 100.0);
+    print_estimate("Page fault rate (%)", &SampleWindow::faults, &SampleWindow::vm_accesses, 100.0);
+    if (ratio_estimate(&SampleWindow::faults, &SampleWindow::vm_accesses, r, ci)){
+        cout << "Est. page faults: " << fixed << setprecision(0) << r * sample_vm_total << " +/- ";
+        print_interval(ci, sample_vm_total);
+        cout << "\n";
+    }
+
+    // with too short a warm-up the start of each window still sees cold caches /
+    // pages, so its latency runs above the rest of the window
+    size_t head_n = 0, head_lat = 0, tail_n = 0, tail_lat = 0;
+    for (auto &w : windows){
+        head_n += w.head_accesses;
+        head_lat += w.head_latency;
+        tail_n += w.accesses - w.head_accesses;
+        tail_lat += w.latency - w.head_latency;
+    }
+    if (head_n && tail_n){
+        double head = (double)head_lat / head_n, tail = (double)tail_lat / tail_n;
+        cout << "Warm-up bias (window 1st vs 2nd half): " << fixed << setprecision(2) << head << " vs " << tail;
+        if (tail > 0) cout << " (" << (head - tail) / tail * 100 << "%)";
+        cout << "\n";
+    }
+}
+
+void save_sampling_state(ostream &out){
+    snap_write(out, (uint64_t)sample_period);
+    snap_write(out, (uint64_t)sample_window);
+    snap_write(out, (uint64_t)sample_warmup);
+    snap_write(out, (uint64_t)sample_pos);
+    snap_write(out, (uint64_t)sample_warmed);
+    snap_write(out, (uint64_t)sample_vm_total);
+    snap_write_vec(out, windows);
+}
+
+bool load_sampling_state(istream &in){
+    uint64_t period, window, warmup, pos, warmed, vm_total;
+    vector<SampleWindow> new_windows;
+    if (!snap_read(in, period) || !snap_read(in, window) || !snap_read(in, warmup) || !snap_read(in, pos) ||
+        !snap_read(in, warmed) || !snap_read(in, vm_total) || !snap_read_vec(in, new_windows))
+        return false;
+    if (period == 0){
+        if (window || warmup || pos || warmed || vm_total || !new_windows.empty()) return false;
+    }
+    else {
+        if (window == 0 || window > period || warmup > period - window) return false;
+        // one window is opened each time the detailed part of a period starts
+        uint64_t detail_start = period - window;
+        if (new_windows.size() != pos / period + (pos % period > detail_start ? 1 : 0)) return false;
+    }
+
+    sample_period = period;
+    sample_window = window;
+    sample_warmup = warmup;
+    sample_pos = pos;
+    sample_warmed = warmed;
+    sample_vm_total = vm_total;
+    windows = new_windows;
+    return true;
+}
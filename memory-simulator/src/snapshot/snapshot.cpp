@@ -0,0 +1,165 @@
+#include "../../include/memsim.h"
+
+// Checkpoint layout:
+//   magic[8] | version (u32) | payload length (u64) | checksum (u64) | payload
+// The payload is the raw state of every subsystem in a fixed order, so a
+// snapshot is only meant to be restored by the same build that wrote it.
+
+static const char SNAP_MAGIC[8] = {'M', 'E', 'M', 'S', 'N', 'A', 'P', '1'};
+static const uint32_t SNAP_VERSION = 6;
+
+// FNV-1a, cheap enough to verify the whole payload before touching any state
+static uint64_t checksum(const string &data){
+    uint64_t h = 1469598103934665603ULL;
+    for (unsigned char ch : data){
+        h ^= ch;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static void save_cache_state(ostream &out, const Cache &c){
+    snap_write(out, (uint64_t)c.name.size());
+    out.write(c.name.data(), c.name.size());
+    snap_write(out, (uint64_t)c.cache_size);
+    snap_write(out, (uint64_t)c.block_size);
+    snap_write(out, (uint64_t)c.associativity);
+    snap_write(out, (uint64_t)c.num_sets);
+    snap_write(out, (uint64_t)c.time);
+    snap_write(out, (uint64_t)c.accesses);
+    snap_write(out, (uint64_t)c.hits);
+    snap_write(out, (uint64_t)c.misses);
+    snap_write(out, c.policy);
+    for (auto &set : c.sets)
+        out.write(reinterpret_cast<const char *>(set.data()), set.size() * sizeof(CacheLine));
+}
+
+static bool load_cache_state(istream &in, Cache &c){
+    uint64_t name_len, cache_size, block_size, assoc, num_sets, time, accesses, hits, misses;
+    int32_t policy;
+    if (!snap_read(in, name_len) || !snap_fits(in, name_len)) return false;
+    string name(name_len, '\0');
+    if (!in.read(&name[0], name_len)) return false;
+    if (!snap_read(in, cache_size) || !snap_read(in, block_size) || !snap_read(in, assoc) ||
+        !snap_read(in, num_sets) || !snap_read(in, time) || !snap_read(in, accesses) ||
+        !snap_read(in, hits) || !snap_read(in, misses) || !snap_read(in, policy))
+        return false;
+    // same invariants init_cache enforces, access_cache divides by these
+    if (block_size == 0 || assoc == 0 || num_sets == 0 || (policy != FIFO && policy != LRU))
+        return false;
+    if (cache_size % (block_size * assoc) != 0 || cache_size / block_size / assoc != num_sets)
+        return false;
+    if (num_sets > SIZE_MAX / assoc / sizeof(CacheLine) || !snap_fits(in, num_sets * assoc * sizeof(CacheLine)))
+        return false;
+
+    vector<vector<CacheLine>> sets(num_sets, vector<CacheLine>(assoc));
+    for (auto &set : sets)
+        if (!in.read(reinterpret_cast<char *>(set.data()), set.size() * sizeof(CacheLine)))
+            return false;
+
+    c.name = name;
+    c.cache_size = cache_size;
+    c.block_size = block_size;
+    c.associativity = assoc;
+    c.num_sets = num_sets;
+    c.time = time;
+    c.accesses = accesses;
+    c.hits = hits;
+    c.misses = misses;
+    c.policy = (ReplacementPolicy)policy;
+    c.sets = move(sets);
+    return true;
+}
+
+// Whole simulator state, in payload order
+
+static void write_state(ostream &out){
+    save_cache_state(out, L1);
+    save_cache_state(out, L2);
+    save_cache_state(out, L3);
+    snap_write(out, (uint64_t)total_memory_accesses);
+    snap_write(out, (uint64_t)total_access_time);
+    snap_write(out, (uint64_t)l1_miss_to_l2);
+    snap_write(out, (uint64_t)l2_miss_to_l3);
+    snap_write(out, (uint64_t)l3_miss_to_memory);
+    save_allocator_state(out);
+    save_buddy_state(out);
+    save_vm_state(out);
+    save_numa_state(out);
+    save_sampling_state(out);
+}
+
+// each subsystem commits as soon as its own section parses, so a failure
+// part way through leaves earlier subsystems already replaced
+static bool read_state(istream &in){
+    Cache c1, c2, c3;
+    uint64_t accesses, access_time, to_l2, to_l3, to_mem;
+    if (!load_cache_state(in, c1) || !load_cache_state(in, c2) || !load_cache_state(in, c3))
+        return false;
+    if (!snap_read(in, accesses) || !snap_read(in, access_time) ||
+        !snap_read(in, to_l2) || !snap_read(in, to_l3) || !snap_read(in, to_mem))
+        return false;
+    L1 = move(c1);
+    L2 = move(c2);
+    L3 = move(c3);
+    total_memory_accesses = accesses;
+    total_access_time = access_time;
+    l1_miss_to_l2 = to_l2;
+    l2_miss_to_l3 = to_l3;
+    l3_miss_to_memory = to_mem;
+
+    return load_allocator_state(in) && load_buddy_state(in) && load_vm_state(in) &&
+           load_numa_state(in) && load_sampling_state(in);
+}
+
+// Save
+
+bool save_snapshot(const string &path){
+    ostringstream payload;
+    write_state(payload);
+
+    string data = payload.str();
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out) return false;
+    out.write(SNAP_MAGIC, sizeof(SNAP_MAGIC));
+    snap_write(out, SNAP_VERSION);
+    snap_write(out, (uint64_t)data.size());
+    snap_write(out, checksum(data));
+    out.write(data.data(), data.size());
+    return (bool)out;
+}
+
+// Restore
+
+bool load_snapshot(const string &path){
+    ifstream in(path, ios::binary | ios::ate);
+    if (!in) return false;
+    uint64_t file_size = (uint64_t)in.tellg();
+    in.seekg(0);
+
+    char magic[sizeof(SNAP_MAGIC)];
+    uint32_t version;
+    uint64_t len, sum;
+    if (!in.read(magic, sizeof(magic)) || memcmp(magic, SNAP_MAGIC, sizeof(magic)) != 0)
+        return false;
+    if (!snap_read(in, version) || version != SNAP_VERSION) return false;
+    if (!snap_read(in, len) || !snap_read(in, sum)) return false;
+
+    // the length field is untrusted until it agrees with what is actually in the file
+    if (len != file_size - (uint64_t)in.tellg()) return false;
+
+    // pull the payload in with a single read and verify it before any subsystem is touched
+    string data(len, '\0');
+    if (!in.read(&data[0], len) || checksum(data) != sum) return false;
+
+    // a checksummed payload can still be malformed, so keep the current state
+    // around and roll back to it if parsing fails or leaves bytes unread
+    ostringstream backup;
+    write_state(backup);
+    istringstream payload(data);
+    if (read_state(payload) && payload.peek() == EOF) return true;
+
+    istringstream restore(backup.str());
+    read_state(restore);
+    return false;
+}
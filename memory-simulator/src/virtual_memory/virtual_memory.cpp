@@ -12,6 +12,7 @@ struct PageTableEntry
     bool valid = false;
     size_t frame = 0;
     size_t timestamp = 0;   // insertion time (FIFO) orr last access (LRU)
+    size_t remote_hits = 0; // hits from a remote cpu node (migrate-on-hot)
 };
 
 static vector<PageTableEntry> page_table;
@@ -36,9 +37,69 @@ void init_vm(size_t physical_memory_size, size_t page_size)
     page_faults = 0;
 }
 
+// NUMA frame pools
+
+static int frame_node(size_t frame)
+{
+    return numa_node_of(frame, NUM_FRAMES);
+}
+
+// first free frame of `node` (-1 = any node), NUM_FRAMES if there is none
+static size_t find_free_frame(int node)
+{
+    size_t lo = node < 0 ? 0 : numa_range_start(node, NUM_FRAMES);
+    size_t hi = node < 0 ? NUM_FRAMES : numa_range_start(node + 1, NUM_FRAMES);
+    for (size_t i = lo; i < hi; i++){
+        if (frame_to_page[i] == -1)
+            return i;
+    }
+    return NUM_FRAMES;
+}
+
+// evicts the oldest page held on `node` (any node if it holds none) and returns its frame,
+// NUM_FRAMES when no page is resident at all
+static size_t evict_victim(int node)
+{
+    size_t victim = VIRTUAL_PAGES;
+    size_t oldest = SIZE_MAX;
+    for (int pass = 0; pass < 2 && victim == VIRTUAL_PAGES; pass++){
+        for (size_t p = 0; p < VIRTUAL_PAGES; p++){
+            if (!page_table[p].valid || page_table[p].timestamp >= oldest) continue;
+            if (pass == 0 && frame_node(page_table[p].frame) != node) continue;
+            oldest = page_table[p].timestamp;
+            victim = p;
+        }
+    }
+    if (victim == VIRTUAL_PAGES) return NUM_FRAMES;
+    size_t frame = page_table[victim].frame;
+    page_table[victim].valid = false;
+    frame_to_page[frame] = -1;
+    return frame;
+}
+
+// moves a hot page onto `node`, evicting the oldest page there if the pool is full
+static void migrate_page(size_t page, int node, bool count)
+{
+    if (numa_range_start(node, NUM_FRAMES) == numa_range_start(node + 1, NUM_FRAMES))
+        return;   // node has no frames of its own
+    size_t frame = find_free_frame(node);
+    if (frame == NUM_FRAMES){
+        // keep the page itself out of the victim search
+        page_table[page].valid = false;
+        frame = evict_victim(node);
+        page_table[page].valid = true;
+        if (frame == NUM_FRAMES) return;
+    }
+    frame_to_page[page_table[page].frame] = -1;
+    page_table[page].frame = frame;
+    page_table[page].remote_hits = 0;
+    frame_to_page[frame] = static_cast<int>(page);
+    if (count) numa_record_migration(frame_node(frame));
+}
+
 // Address Translation
 
-size_t translate_address(size_t virtual_addr)
+static size_t translate(size_t virtual_addr, bool count)
 {
     vm_time++;
     size_t page = virtual_addr / PAGE_SIZE;
@@ -51,45 +112,66 @@ size_t translate_address(size_t virtual_addr)
     }
     if (page_table[page].valid) // page hit if else block
     {
-        page_hits++;
+        if (count) page_hits++;
         if (vm_policy == LRU_VM)
             page_table[page].timestamp = vm_time;
-        return page_table[page].frame * PAGE_SIZE + offset;
-    }
-    page_faults++; // page fault
-
-    // find free frame
-    size_t frame = NUM_FRAMES;
-    for (size_t i = 0; i < NUM_FRAMES; i++){
-        if (frame_to_page[i] == -1){
-            frame = i;
-            break;
+        if (numa_enabled() && get_numa_policy() == MIGRATE_ON_HOT && frame_node(page_table[page].frame) != get_cpu_node()){
+            if (++page_table[page].remote_hits >= numa_hot_threshold())
+                migrate_page(page, get_cpu_node(), count);
         }
+        return page_table[page].frame * PAGE_SIZE + offset;
     }
-
-    // no free frame → replace victim
+    if (count) page_faults++; // page fault
+
+    // find free frame on the node chosen by the placement policy,
+    // spilling to other nodes unless the policy binds us to one that has frames
+    int node = numa_pick_node();
+    bool bound = get_numa_policy() == BIND &&
+                 numa_range_start(node, NUM_FRAMES) != numa_range_start(node + 1, NUM_FRAMES);
+    size_t frame = find_free_frame(node);
+    if (frame == NUM_FRAMES && !bound)
+        frame = find_free_frame(-1);
+
+    // no free frame → replace victim (from the target node's pool when possible)
+    if (frame == NUM_FRAMES)
+        frame = evict_victim(node);
     if (frame == NUM_FRAMES){
-        size_t victim = 0;
-        size_t oldest = SIZE_MAX;
-        for (size_t p = 0; p < VIRTUAL_PAGES; p++){
-            if (page_table[p].valid && page_table[p].timestamp < oldest){
-                oldest = page_table[p].timestamp;
-                victim = p;
-            }
-        }
-        frame = page_table[victim].frame;
-        page_table[victim].valid = false;
-        frame_to_page[frame] = -1;
+        cerr << "No physical frames\n";
+        return 0;
     }
+
     // load new page
     page_table[page].valid = true;
     page_table[page].frame = frame;
     page_table[page].timestamp = vm_time;
+    page_table[page].remote_hits = 0;
     frame_to_page[frame] = static_cast<int>(page);
+    if (count) numa_record_placement(frame_node(frame));
 
     return frame * PAGE_SIZE + offset;
 }
 
+size_t translate_address(size_t virtual_addr)
+{
+    return translate(virtual_addr, true);
+}
+
+// Functional warming: keeps page table / frames in step without counting hits or faults
+size_t warm_translate(size_t virtual_addr)
+{
+    return translate(virtual_addr, false);
+}
+
+int vm_node_of(size_t physical_addr)
+{
+    return PAGE_SIZE ? frame_node(physical_addr / PAGE_SIZE) : 0;
+}
+
+size_t get_page_faults()
+{
+    return page_faults;
+}
+
 
 void set_vm_policy(VMReplacement p)
 {
@@ -111,3 +193,55 @@ void dump_page_table()
         }
     }
 }
+
+// Snapshot
+
+void save_vm_state(ostream &out)
+{
+    snap_write(out, (uint64_t)PAGE_SIZE);
+    snap_write(out, (uint64_t)NUM_FRAMES);
+    snap_write(out, (uint64_t)VIRTUAL_PAGES);
+    snap_write(out, vm_policy);
+    snap_write(out, (uint64_t)vm_time);
+    snap_write(out, (uint64_t)page_hits);
+    snap_write(out, (uint64_t)page_faults);
+    snap_write_vec(out, page_table);
+    snap_write_vec(out, frame_to_page);
+}
+
+bool load_vm_state(istream &in)
+{
+    uint64_t page_size, frames, pages, time, hits, faults;
+    int32_t policy;
+    vector<PageTableEntry> table;
+    vector<int> frames_map;
+    if (!snap_read(in, page_size) || !snap_read(in, frames) || !snap_read(in, pages) ||
+        !snap_read(in, policy) || !snap_read(in, time) || !snap_read(in, hits) ||
+        !snap_read(in, faults) || !snap_read_vec(in, table) || !snap_read_vec(in, frames_map))
+        return false;
+    if (table.size() != pages || frames_map.size() != frames)
+        return false;
+    if ((policy != FIFO_VM && policy != LRU_VM) || (frames > 0 && page_size == 0))
+        return false;
+    // page table and frame map must point at each other
+    for (size_t p = 0; p < pages; p++){
+        if (table[p].valid && (table[p].frame >= frames || frames_map[table[p].frame] != (int)p))
+            return false;
+    }
+    for (size_t f = 0; f < frames; f++){
+        int p = frames_map[f];
+        if (p != -1 && (p < 0 || (uint64_t)p >= pages || !table[p].valid || table[p].frame != f))
+            return false;
+    }
+
+    PAGE_SIZE = page_size;
+    NUM_FRAMES = frames;
+    VIRTUAL_PAGES = pages;
+    vm_policy = (VMReplacement)policy;
+    vm_time = time;
+    page_hits = hits;
+    page_faults = faults;
+    page_table = move(table);
+    frame_to_page = move(frames_map);
+    return true;
+}
@@ -0,0 +1,345 @@
+#include "../../include/memsim.h"
+
+// Synthetic workload generator. Ops are produced in fixed-size batches, each
+// batch filled by a tight per-pattern loop, and handed to a sink (the live
+// simulator or a trace file). All randomness comes from one seeded
+// xoshiro256** stream, so the same parameters + seed give the same ops.
+
+static const size_t GEN_BATCH = 4096;
+static const size_t MAX_CHASE_NODES = 1 << 24;
+static const size_t MAX_ZIPF_ITEMS = 1 << 24;
+
+// Parameters (gen_param <key> <value>)
+static size_t gen_base = 0;
+static size_t gen_span = 4096;
+static size_t gen_stride = 64;
+static size_t gen_elem = 8;
+static size_t gen_hot_set = 64;
+static double gen_zipf_theta = 0.99;
+static size_t gen_matrix_n = 32;
+static size_t gen_tile = 8;
+static bool gen_vm = false;
+enum SizeDist
+{
+    SIZE_UNIFORM,
+    SIZE_CLASSES,
+    SIZE_PARETO
+};
+enum FreeOrder
+{
+    FREE_LIFO,
+    FREE_FIFO,
+    FREE_RANDOM
+};
+
+static SizeDist gen_size_dist = SIZE_CLASSES;
+static size_t gen_min_size = 8;
+static size_t gen_max_size = 256;
+static FreeOrder gen_free_order = FREE_LIFO;
+static size_t gen_live_max = 16;
+
+// numeric parameters reject anything that is not a plain number instead of aborting
+static bool set_size(size_t &dst, const string &value, size_t min_value){
+    size_t v;
+    if (!parse_size(value, v)) return false;
+    dst = max(v, min_value);
+    return true;
+}
+
+static bool set_theta(const string &value){
+    char *end = nullptr;
+    errno = 0;
+    double v = strtod(value.c_str(), &end);
+    if (value.empty() || *end != '\0' || errno == ERANGE || !isfinite(v) || v < 0) return false;
+    gen_zipf_theta = v;
+    return true;
+}
+
+bool set_workload_param(const string &key, const string &value){
+    if (key == "base") return set_size(gen_base, value, 0);
+    if (key == "span") return set_size(gen_span, value, 1);
+    if (key == "stride") return set_size(gen_stride, value, 0);
+    if (key == "elem") return set_size(gen_elem, value, 1);
+    if (key == "hot_set") return set_size(gen_hot_set, value, 1);
+    if (key == "zipf_theta") return set_theta(value);
+    if (key == "matrix_n") return set_size(gen_matrix_n, value, 1);
+    if (key == "tile") return set_size(gen_tile, value, 1);
+    if (key == "min_size") return set_size(gen_min_size, value, 1);
+    if (key == "max_size") return set_size(gen_max_size, value, 1);
+    if (key == "live_max") return set_size(gen_live_max, value, 1);
+    if (key == "vm" && (value == "1" || value == "on")) gen_vm = true;
+    else if (key == "vm" && (value == "0" || value == "off")) gen_vm = false;
+    else if (key == "size_dist" && value == "uniform") gen_size_dist = SIZE_UNIFORM;
+    else if (key == "size_dist" && value == "classes") gen_size_dist = SIZE_CLASSES;
+    else if (key == "size_dist" && value == "pareto") gen_size_dist = SIZE_PARETO;
+    else if (key == "free_order" && value == "lifo") gen_free_order = FREE_LIFO;
+    else if (key == "free_order" && value == "fifo") gen_free_order = FREE_FIFO;
+    else if (key == "free_order" && value == "random") gen_free_order = FREE_RANDOM;
+    else return false;
+    return true;
+}
+
+// RNG: xoshiro256** seeded through splitmix64
+
+struct GenRng
+{
+    uint64_t s[4];
+
+    explicit GenRng(uint64_t seed){
+        for (auto &x : s){
+            seed += 0x9e3779b97f4a7c15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            x = z ^ (z >> 31);
+        }
+    }
+    static uint64_t rotl(uint64_t x, int k){
+        return (x << k) | (x >> (64 - k));
+    }
+    uint64_t next(){
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+    // uniform in [0, n)
+    uint64_t below(uint64_t n){
+        return (uint64_t)(((unsigned __int128)next() * n) >> 64);
+    }
+    // uniform in [0, 1)
+    double unit(){
+        return (next() >> 11) * 0x1.0p-53;
+    }
+};
+
+// Access patterns
+
+enum AccessPattern
+{
+    PAT_SEQ,
+    PAT_STRIDE,
+    PAT_RANDOM,
+    PAT_ZIPF,
+    PAT_CHASE,
+    PAT_MATRIX
+};
+
+struct AccessGen
+{
+    AccessPattern pattern;
+    size_t t = 0;                 // ops generated so far
+    size_t slots = 1;             // elem-sized slots in the span
+    vector<double> zipf_cdf;
+    vector<uint32_t> chase_next;
+    size_t chase_cur = 0;
+};
+
+static bool parse_pattern(const string &name, AccessPattern &p){
+    if (name == "seq") p = PAT_SEQ;
+    else if (name == "stride") p = PAT_STRIDE;
+    else if (name == "random") p = PAT_RANDOM;
+    else if (name == "zipf") p = PAT_ZIPF;
+    else if (name == "chase") p = PAT_CHASE;
+    else if (name == "matrix") p = PAT_MATRIX;
+    else return false;
+    return true;
+}
+
+static void setup_access(AccessGen &g, GenRng &rng){
+    g.slots = max(gen_span / gen_elem, (size_t)1);
+    if (g.pattern == PAT_ZIPF){
+        // P(rank r) ~ 1 / r^theta over the hot set
+        size_t items = min(gen_hot_set, MAX_ZIPF_ITEMS);
+        g.zipf_cdf.resize(items);
+        double sum = 0;
+        for (size_t r = 0; r < items; r++){
+            sum += 1.0 / pow((double)(r + 1), gen_zipf_theta);
+            g.zipf_cdf[r] = sum;
+        }
+        for (auto &c : g.zipf_cdf) c /= sum;
+    }
+    else if (g.pattern == PAT_CHASE){
+        // linking order[i] -> order[i + 1] puts every node on one cycle for any
+        // permutation; a Fisher-Yates shuffle makes the order of that cycle random
+        size_t nodes = min(g.slots, MAX_CHASE_NODES);
+        vector<uint32_t> order(nodes);
+        for (size_t i = 0; i < nodes; i++) order[i] = i;
+        for (size_t i = nodes - 1; i > 0; i--) swap(order[i], order[rng.below(i + 1)]);
+        g.chase_next.resize(nodes);
+        for (size_t i = 0; i < nodes; i++) g.chase_next[order[i]] = order[(i + 1) % nodes];
+    }
+}
+
+// fills addrs[0..n) with the next n addresses of the pattern
+static void fill_access(AccessGen &g, GenRng &rng, size_t *addrs, size_t n){
+    switch (g.pattern){
+    case PAT_SEQ:
+        for (size_t i = 0; i < n; i++) addrs[i] = gen_base + ((g.t + i) % g.slots) * gen_elem;
+        break;
+    case PAT_STRIDE:
+        for (size_t i = 0; i < n; i++) addrs[i] = gen_base + ((g.t + i) * gen_stride) % gen_span;
+        break;
+    case PAT_RANDOM:
+        for (size_t i = 0; i < n; i++) addrs[i] = gen_base + rng.below(g.slots) * gen_elem;
+        break;
+    case PAT_ZIPF:
+        // hot items are spread `stride` apart so popular ones land in different lines
+        for (size_t i = 0; i < n; i++){
+            size_t r = lower_bound(g.zipf_cdf.begin(), g.zipf_cdf.end(), rng.unit()) - g.zipf_cdf.begin();
+            r = min(r, g.zipf_cdf.size() - 1);
+            addrs[i] = gen_base + (r * max(gen_stride, gen_elem)) % gen_span;
+        }
+        break;
+    case PAT_CHASE:
+        for (size_t i = 0; i < n; i++){
+            g.chase_cur = g.chase_next[g.chase_cur];
+            addrs[i] = gen_base + g.chase_cur * gen_elem;
+        }
+        break;
+    case PAT_MATRIX:{
+        // tiled C += A * B: loops ii, jj, kk over tiles then i, j, k inside, three accesses per step
+        size_t nn = gen_matrix_n, tile = min(gen_tile, nn);
+        size_t tiles = (nn + tile - 1) / tile;
+        size_t a = gen_base, b = a + nn * nn * gen_elem, c = b + nn * nn * gen_elem;
+        for (size_t i = 0; i < n; i++){
+            size_t q = (g.t + i) / 3, which = (g.t + i) % 3;
+            size_t k = q % tile; q /= tile;
+            size_t j = q % tile; q /= tile;
+            size_t r = q % tile; q /= tile;
+            size_t kk = q % tiles; q /= tiles;
+            size_t jj = q % tiles; q /= tiles;
+            size_t ii = q % tiles;
+            size_t row = min(ii * tile + r, nn - 1);
+            size_t col = min(jj * tile + j, nn - 1);
+            size_t mid = min(kk * tile + k, nn - 1);
+            if (which == 0) addrs[i] = a + (row * nn + mid) * gen_elem;
+            else if (which == 1) addrs[i] = b + (mid * nn + col) * gen_elem;
+            else addrs[i] = c + (row * nn + col) * gen_elem;
+        }
+        break;
+    }
+    }
+    g.t += n;
+}
+
+// Allocation lifetimes
+
+// small size classes in the style of jemalloc/tcmalloc, smaller ones are far more common
+static const size_t ALLOC_CLASSES[] = {8, 16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256,
+                                       320, 384, 448, 512, 640, 768, 896, 1024, 1280, 1536, 1792, 2048};
+
+struct AllocGen
+{
+    size_t handles = 0;           // mallocs emitted so far, handle h is the h-th malloc
+    deque<size_t> live;
+    vector<size_t> classes;       // ALLOC_CLASSES inside [min_size, max_size]
+};
+
+static size_t draw_size(AllocGen &g, GenRng &rng){
+    size_t lo = gen_min_size, hi = max(gen_max_size, gen_min_size);
+    if (gen_size_dist == SIZE_UNIFORM)
+        return lo + rng.below(hi - lo + 1);
+    if (gen_size_dist == SIZE_PARETO){
+        // heavy tail, alpha = 1.5
+        double v = lo / pow(1.0 - rng.unit(), 1.0 / 1.5);
+        return (size_t)min(v, (double)hi);
+    }
+    // classes: geometric pick over the ALLOC_CLASSES inside [min_size, max_size]
+    if (g.classes.empty()) return lo;
+    size_t idx = 0;
+    while (idx + 1 < g.classes.size() && rng.unit() < 0.7) idx++;
+    // jitter inside the class so internal fragmentation is exercised
+    size_t below = idx ? g.classes[idx - 1] : lo - 1;
+    return below + 1 + rng.below(g.classes[idx] - below);
+}
+
+static void fill_alloc(AllocGen &g, GenRng &rng, vector<WorkOp> &ops, size_t n){
+    for (size_t i = 0; i < n; i++){
+        bool do_alloc = g.live.empty() || (g.live.size() < gen_live_max && rng.below(2) == 0);
+        if (do_alloc){
+            ops.push_back({OP_MALLOC, draw_size(g, rng)});
+            g.live.push_back(g.handles++);
+            continue;
+        }
+        size_t h;
+        if (gen_free_order == FREE_LIFO){
+            h = g.live.back();
+            g.live.pop_back();
+        }
+        else if (gen_free_order == FREE_FIFO){
+            h = g.live.front();
+            g.live.pop_front();
+        }
+        else{
+            size_t pick = rng.below(g.live.size());
+            h = g.live[pick];
+            g.live[pick] = g.live.back();
+            g.live.pop_back();
+        }
+        ops.push_back({OP_FREE, h});
+    }
+}
+
+// Driver
+
+bool generate_workload(const string &pattern, size_t count, uint64_t seed, const function<void(const vector<WorkOp> &)> &sink){
+    GenRng rng(seed);
+    vector<WorkOp> ops;
+    ops.reserve(GEN_BATCH);
+
+    if (pattern == "alloc"){
+        AllocGen g;
+        for (size_t c : ALLOC_CLASSES)
+            if (c >= gen_min_size && c <= gen_max_size) g.classes.push_back(c);
+        for (size_t done = 0; done < count; done += GEN_BATCH){
+            ops.clear();
+            fill_alloc(g, rng, ops, min(GEN_BATCH, count - done));
+            sink(ops);
+        }
+        return true;
+    }
+
+    AccessGen g;
+    if (!parse_pattern(pattern, g.pattern)) return false;
+    setup_access(g, rng);
+    WorkOpKind kind = gen_vm ? OP_VM_ACCESS : OP_ACCESS;
+    vector<size_t> addrs(GEN_BATCH);
+    for (size_t done = 0; done < count; done += GEN_BATCH){
+        size_t n = min(GEN_BATCH, count - done);
+        fill_access(g, rng, addrs.data(), n);
+        ops.resize(n);
+        for (size_t i = 0; i < n; i++) ops[i] = {kind, addrs[i]};
+        sink(ops);
+    }
+    return true;
+}
+
+// Trace output: same commands the CLI reads. free ids assume the trace is
+// replayed on a freshly initialized allocator where every malloc succeeds.
+
+bool write_workload_trace(const string &path, const string &pattern, size_t count, uint64_t seed){
+    ofstream out(path);
+    if (!out) return false;
+    string buf;
+    bool ok = generate_workload(pattern, count, seed, [&](const vector<WorkOp> &ops){
+        buf.clear();
+        for (auto &op : ops){
+            switch (op.kind){
+            case OP_ACCESS: buf += "access "; break;
+            case OP_VM_ACCESS: buf += "vm_access "; break;
+            case OP_MALLOC: buf += "malloc "; break;
+            case OP_FREE: buf += "free "; break;
+            }
+            buf += to_string(op.kind == OP_FREE ? op.value + 1 : op.value);
+            buf += '\n';
+        }
+        out << buf;
+    });
+    return ok && (bool)out;
+}